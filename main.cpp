@@ -17,23 +17,37 @@ The program also includes functionality for handling data validation errors and
 solution exceptions, and for outputting the identified solutions to a storage
 file.
 
+Results are stored in a compact binary file (see writeResultsToStorage). Run
+the program with --read to turn such a file back into the text layout, with
+optional word and score filters.
+
+Run the program with --square to search for true 5x5 word squares instead,
+where every row and column is a word (see runSquares).
+
 The program is written in C++ and makes use of several standard libraries,
-including <algorithm>, <cctype>, <chrono>, <fstream>, <iomanip>, <ios>,
-<iostream>, <set>, <sstream>, <stdexcept>, <string>, <unordered_map>,
-<unordered_set>, <utility>, and <vector>.
+including <algorithm>, <array>, <atomic>, <cctype>, <chrono>, <cstdint>,
+<fstream>, <iomanip>, <ios>, <iostream>, <iterator>, <limits>, <set>,
+<sstream>, <stdexcept>, <string>, <thread>, <unordered_map>, <unordered_set>,
+<utility>, and <vector>.
 *******************************************************************************/
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <ios>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -41,12 +55,17 @@ including <algorithm>, <cctype>, <chrono>, <fstream>, <iomanip>, <ios>,
 
 using namespace std::chrono;
 
-const int SOLUTION_SIZE(5); // number of letters in word, words in solution
-const auto START_TIME(steady_clock::now());
-
 typedef unsigned long ul;
 typedef std::unordered_map<int, ul> mChar;
 
+const int SOLUTION_SIZE(5); // number of letters in word, words in solution
+const auto START_TIME(steady_clock::now());
+const ul CHECKPOINT_INTERVAL(64);    // records between random access points
+const std::string RESULTS_MAGIC("WSQB");
+const std::string INDEX_MAGIC("WSQI");
+const unsigned char RESULTS_VERSION(1);
+const unsigned char FLAG_WORD_INDEX(1);
+
 class DataValidationException : public std::exception {
 public:
   explicit DataValidationException(const std::string &errorMessage)
@@ -79,7 +98,7 @@ private:
 
 public:
   Word() { reset(); }
-  Word(std::string _word) {
+  Word(std::string _word, bool uniqueLetters = true) {
     reset();
     if (_word.size() != SOLUTION_SIZE) {
       throw DataValidationException("Must have exactly five letters.");
@@ -90,7 +109,7 @@ public:
       if (!isprint(c)) {
         throw DataValidationException("All characters must be letters.");
       }
-      if (letters.count(c) > 0) {
+      if (uniqueLetters && letters.count(c) > 0) {
         throw DataValidationException("All letters in word must be unique.");
       }
       letters.insert(c);
@@ -183,7 +202,7 @@ public:
 
   bool isSolved() { return wordCollection.size() == SOLUTION_SIZE; }
 
-  sWord getWordCollection() { return wordCollection; }
+  const sWord &getWordCollection() const { return wordCollection; }
 
   void setDur() {
     auto tmp(steady_clock::now() - START_TIME);
@@ -202,6 +221,8 @@ public:
 
   ul getCollectionSize() { return wordCollection.size(); }
 
+  ul getDur() const { return dur; }
+
   int getScore() const { return score; }
 
   void addWord(Word aWord) {
@@ -245,6 +266,179 @@ public:
 };
 typedef std::vector<Solution> vSol;
 
+/*******************************************************************************
+ PrefixTrie class.
+ Array based trie over lowercase words. Each node keeps a bitmask of the
+ letters that can follow it and the position of its first child; children are
+ stored contiguously in letter order, so a child is found by counting the mask
+ bits below its letter. Nodes are laid out breadth first, root at 0.
+ *******************************************************************************/
+class PrefixTrie {
+private:
+  std::vector<uint32_t> masks;      // letters present below each node
+  std::vector<uint32_t> firstChild; // index of the lowest letter's child
+
+public:
+  static const uint32_t ROOT = 0;
+
+  PrefixTrie() { reset(); }
+  ~PrefixTrie() { reset(); }
+
+  void reset() {
+    masks.clear();
+    firstChild.clear();
+  }
+
+  // words must be sorted, unique, SOLUTION_SIZE long and all 'a'..'z'
+  void build(const std::vector<std::string> &words) {
+    reset();
+    struct Pending {
+      uint32_t node;
+      size_t lo, hi;
+      int depth;
+    };
+    std::vector<Pending> queue;
+    masks.push_back(0);
+    firstChild.push_back(0);
+    queue.push_back({ROOT, 0, words.size(), 0});
+    for (size_t q = 0; q < queue.size(); q++) {
+      Pending p(queue[q]);
+      if (p.depth == SOLUTION_SIZE) {
+        continue;
+      }
+      firstChild[p.node] = masks.size();
+      size_t lo(p.lo);
+      while (lo < p.hi) {
+        char c(words[lo][p.depth]);
+        size_t hi(lo);
+        while (hi < p.hi && words[hi][p.depth] == c) {
+          hi++;
+        }
+        masks[p.node] |= 1u << (c - 'a');
+        queue.push_back({static_cast<uint32_t>(masks.size()), lo, hi,
+                         p.depth + 1});
+        masks.push_back(0);
+        firstChild.push_back(0);
+        lo = hi;
+      }
+    }
+  }
+
+  uint32_t getMask(uint32_t node) const { return masks[node]; }
+
+  // caller guarantees the letter is in the node's mask
+  uint32_t child(uint32_t node, int letter) const {
+    return firstChild[node] +
+           __builtin_popcount(masks[node] & ((1u << letter) - 1));
+  }
+
+  ul size() const { return masks.size(); }
+};
+const uint32_t PrefixTrie::ROOT;
+
+/*******************************************************************************
+ Square class.
+ Workspace for one search thread. Rows are filled one at a time, letter by
+ letter; each letter must continue both the row's prefix and its column's
+ prefix in the trie, so dead column prefixes are cut off as soon as they
+ appear. Without doubleSquare the square is symmetric (row i == column i);
+ with it all ten rows and columns must be different words.
+ *******************************************************************************/
+class Square {
+private:
+  const PrefixTrie &trie;
+  bool doubleSquare;
+  std::array<std::array<char, SOLUTION_SIZE>, SOLUTION_SIZE> grid;
+  std::array<uint32_t, SOLUTION_SIZE> colNodes; // column prefixes so far
+  std::vector<std::string> found;               // rows concatenated
+
+  void fillRow(int r) {
+    if (r == SOLUTION_SIZE) {
+      record();
+      return;
+    }
+    fillCell(r, 0, PrefixTrie::ROOT);
+  }
+
+  void fillCell(int r, int c, uint32_t rowNode) {
+    if (c == SOLUTION_SIZE) {
+      fillRow(r + 1);
+      return;
+    }
+    uint32_t allowed(trie.getMask(rowNode) & trie.getMask(colNodes[c]));
+    if (!doubleSquare && c < r) {
+      allowed &= 1u << (grid[c][r] - 'a');
+    }
+    uint32_t colNode(colNodes[c]);
+    while (allowed != 0) {
+      int letter(__builtin_ctz(allowed));
+      allowed &= allowed - 1;
+      grid[r][c] = 'a' + letter;
+      colNodes[c] = trie.child(colNode, letter);
+      fillCell(r, c + 1, trie.child(rowNode, letter));
+    }
+    colNodes[c] = colNode;
+  }
+
+  void record() {
+    std::string rows, cols;
+    for (int i = 0; i < SOLUTION_SIZE; i++) {
+      for (int j = 0; j < SOLUTION_SIZE; j++) {
+        rows += grid[i][j];
+        cols += grid[j][i];
+      }
+    }
+    if (doubleSquare) {
+      // the transpose is also a double square; keep one of the pair
+      if (cols < rows) {
+        return;
+      }
+      std::set<std::string> distinct;
+      for (int i = 0; i < SOLUTION_SIZE; i++) {
+        distinct.insert(rows.substr(i * SOLUTION_SIZE, SOLUTION_SIZE));
+        distinct.insert(cols.substr(i * SOLUTION_SIZE, SOLUTION_SIZE));
+      }
+      if (distinct.size() != 2 * SOLUTION_SIZE) {
+        return;
+      }
+    }
+    found.emplace_back(rows);
+  }
+
+public:
+  Square(const PrefixTrie &_trie, bool _doubleSquare)
+      : trie(_trie), doubleSquare(_doubleSquare) {
+    reset();
+  }
+  ~Square() { reset(); }
+
+  void reset() {
+    for (auto &row : grid) {
+      row.fill(' ');
+    }
+    colNodes.fill(PrefixTrie::ROOT);
+    found.clear();
+  }
+
+  // every square whose first row is firstRow is appended to found
+  void searchFirstRow(const std::string &firstRow) {
+    for (int c = 0; c < SOLUTION_SIZE; c++) {
+      // no word starts with this letter, so column c cannot be a word
+      if ((trie.getMask(PrefixTrie::ROOT) & (1u << (firstRow[c] - 'a'))) ==
+          0) {
+        return;
+      }
+    }
+    for (int c = 0; c < SOLUTION_SIZE; c++) {
+      grid[0][c] = firstRow[c];
+      colNodes[c] = trie.child(PrefixTrie::ROOT, firstRow[c] - 'a');
+    }
+    fillRow(1);
+  }
+
+  const std::vector<std::string> &getFound() const { return found; }
+};
+
 /*******************************************************************************
  prototypes
  *******************************************************************************/
@@ -263,11 +457,232 @@ void makeLowercase(std::string &str);
 void prependFNwithTS(std::string &, std::string &);
 void pushCurrentSolutionOnSolutions(const mChar &, vSol &, Solution &,
                                     ussWord &);
-void readWordsFromStorage(const std::string &, vWord &, mChar &);
-void termination(const steady_clock::time_point &, vSol &);
-void writeResultsToStorage(const vSol &);
+void readWordsFromStorage(const std::string &, vWord &, mChar &,
+                          bool = true);
+void termination(const steady_clock::time_point &, vSol &, const vWord &,
+                 bool);
+void writeResultsToStorage(const vSol &, const vWord &, bool);
 void writeWordsWithoutDupeLetters(const std::string &, vWord &);
 void recursiveSearch(vWord &, Solution &, vSol &, const mChar &, ussWord &);
+void putVarint(std::string &, uint64_t);
+void putSigned(std::string &, int64_t);
+void putFixed64(std::string &, uint64_t);
+uint64_t getVarint(const std::string &, size_t &);
+int64_t getSigned(const std::string &, size_t &);
+uint64_t getFixed64(const std::string &, size_t);
+uint64_t hashDictionary(const vWord &);
+void encodeResults(const vSol &, const vWord &, bool, std::string &);
+int readResults(const int &, char *[]);
+long parseOption(const std::string &, const std::string &,
+                 long = std::numeric_limits<long>::min());
+int runSquares(const int &, char *[]);
+void squareSearch(const vWord &, bool, unsigned, std::vector<std::string> &);
+void writeSquaresToStorage(const std::vector<std::string> &, mChar &);
+
+/*******************************************************************************
+ ResultsFile class.
+ Read side of the binary results format written by writeResultsToStorage:
+   header:  magic, version, flags, dictionary hash, dictionary size,
+            word table (letters + word score), solution count
+   records: five sorted word table indices (first, then gaps), score residual
+            against the sum of the word scores, duration delta (all varints)
+   index:   optional; checkpoints every CHECKPOINT_INTERVAL records plus a
+            list of record ordinals for each table word, located by a trailer
+ *******************************************************************************/
+class ResultsFile {
+private:
+  std::string buf;
+  unsigned char flags;
+  uint64_t dictHash;
+  ul dictSize;
+  ul solutionCount;
+  size_t recordsStart;
+  ul checkpointInterval;
+  std::vector<std::string> table;
+  std::vector<int> tableScores;
+  std::vector<std::pair<size_t, ul>> checkpoints; // record offset, prior dur
+  std::vector<std::vector<ul>> wordIndex;         // record ordinals per word
+
+  void readIndex(size_t pos) {
+    checkpointInterval = getVarint(buf, pos);
+    ul n(getVarint(buf, pos));
+    size_t offset(0);
+    for (ul i = 0; i < n; i++) {
+      offset += getVarint(buf, pos);
+      checkpoints.emplace_back(recordsStart + offset, getVarint(buf, pos));
+    }
+    wordIndex.resize(table.size());
+    for (auto &ordinals : wordIndex) {
+      ul count(getVarint(buf, pos));
+      ul ordinal(0);
+      for (ul i = 0; i < count; i++) {
+        ordinal += getVarint(buf, pos);
+        ordinals.push_back(ordinal);
+      }
+    }
+  }
+
+public:
+  ResultsFile() { reset(); }
+  ~ResultsFile() { reset(); }
+
+  void reset() {
+    buf.clear();
+    flags = 0;
+    dictHash = 0;
+    dictSize = 0;
+    solutionCount = 0;
+    recordsStart = 0;
+    checkpointInterval = 0;
+    table.clear();
+    tableScores.clear();
+    checkpoints.clear();
+    wordIndex.clear();
+  }
+
+  bool load(const std::string &fp) {
+    reset();
+    std::ifstream fin(fp, std::ios::binary);
+    if (!fin.is_open()) {
+      return false;
+    }
+    std::stringstream sst;
+    sst << fin.rdbuf();
+    buf = sst.str();
+    fin.close();
+
+    size_t headerSize(RESULTS_MAGIC.size() + 2 + sizeof(uint64_t));
+    if (buf.size() < headerSize || buf.compare(0, RESULTS_MAGIC.size(),
+                                               RESULTS_MAGIC) != 0) {
+      throw DataValidationException("Not a results file.");
+    }
+    size_t pos(RESULTS_MAGIC.size());
+    if (static_cast<unsigned char>(buf[pos++]) != RESULTS_VERSION) {
+      throw DataValidationException("Unsupported results file version.");
+    }
+    flags = buf[pos++];
+    dictHash = getFixed64(buf, pos);
+    pos += sizeof(uint64_t);
+    dictSize = getVarint(buf, pos);
+
+    ul tableSize(getVarint(buf, pos));
+    for (ul i = 0; i < tableSize; i++) {
+      if (pos + SOLUTION_SIZE > buf.size()) {
+        throw DataValidationException("Truncated word table.");
+      }
+      table.emplace_back(buf.substr(pos, SOLUTION_SIZE));
+      pos += SOLUTION_SIZE;
+      tableScores.push_back(getVarint(buf, pos));
+    }
+    solutionCount = getVarint(buf, pos);
+    recordsStart = pos;
+
+    if (hasWordIndex()) {
+      size_t trailerSize(sizeof(uint64_t) + INDEX_MAGIC.size());
+      if (buf.size() < recordsStart + trailerSize ||
+          buf.compare(buf.size() - INDEX_MAGIC.size(), INDEX_MAGIC.size(),
+                      INDEX_MAGIC) != 0) {
+        throw DataValidationException("Word index trailer missing.");
+      }
+      uint64_t indexStart(getFixed64(buf, buf.size() - trailerSize));
+      if (indexStart < recordsStart || indexStart > buf.size() - trailerSize) {
+        throw DataValidationException("Word index offset out of range.");
+      }
+      readIndex(indexStart);
+    }
+    return true;
+  }
+
+  bool hasWordIndex() const { return (flags & FLAG_WORD_INDEX) != 0; }
+
+  uint64_t getDictHash() const { return dictHash; }
+
+  ul getDictSize() const { return dictSize; }
+
+  ul getSolutionCount() const { return solutionCount; }
+
+  ul getTableSize() const { return table.size(); }
+
+  // table index of aWord, or -1 when no solution uses it
+  long findWord(const std::string &aWord) const {
+    auto it(std::lower_bound(table.begin(), table.end(), aWord));
+    if (it == table.end() || *it != aWord) {
+      return -1;
+    }
+    return it - table.begin();
+  }
+
+  // decodes the record at pos; prevDur carries the duration between records
+  void decodeRecord(size_t &pos, ul &prevDur,
+                    std::array<ul, SOLUTION_SIZE> &indices, int &score) const {
+    int64_t sum(0);
+    for (int i = 0; i < SOLUTION_SIZE; i++) {
+      indices[i] = getVarint(buf, pos) + (i > 0 ? indices[i - 1] : 0);
+      if (indices[i] >= table.size()) {
+        throw DataValidationException("Word table index out of range.");
+      }
+      sum += tableScores[indices[i]];
+    }
+    score = sum + getSigned(buf, pos);
+    prevDur += getSigned(buf, pos);
+  }
+
+  // positions pos/prevDur at record ordinal, using checkpoints when present
+  void seekRecord(ul ordinal, size_t &pos, ul &prevDur) const {
+    ul skip(ordinal);
+    pos = recordsStart;
+    prevDur = 0;
+    if (!checkpoints.empty() && checkpointInterval > 0) {
+      ul c(std::min<ul>(ordinal / checkpointInterval, checkpoints.size() - 1));
+      pos = checkpoints[c].first;
+      prevDur = checkpoints[c].second;
+      skip = ordinal - c * checkpointInterval;
+    }
+    skipRecords(skip, pos, prevDur);
+  }
+
+  // decodes and discards count records from pos
+  void skipRecords(ul count, size_t &pos, ul &prevDur) const {
+    std::array<ul, SOLUTION_SIZE> indices;
+    int score;
+    for (ul i = 0; i < count; i++) {
+      decodeRecord(pos, prevDur, indices, score);
+    }
+  }
+
+  // records between checkpoints, 0 without a word index
+  ul getCheckpointInterval() const { return checkpointInterval; }
+
+  // record ordinals containing every given table word (needs the word index)
+  std::vector<ul> solutionsWithWords(const std::vector<long> &wordIds) const {
+    std::vector<ul> hits;
+    for (size_t i = 0; i < wordIds.size(); i++) {
+      const auto &ordinals(wordIndex[wordIds[i]]);
+      if (i == 0) {
+        hits = ordinals;
+        continue;
+      }
+      std::vector<ul> both;
+      std::set_intersection(hits.begin(), hits.end(), ordinals.begin(),
+                            ordinals.end(), std::back_inserter(both));
+      hits.swap(both);
+    }
+    return hits;
+  }
+
+  std::string formatRecord(const std::array<ul, SOLUTION_SIZE> &indices,
+                           int score, ul dur) const {
+    std::string line(std::to_string(score));
+    for (auto i : indices) {
+      line += ' ';
+      line += table[i];
+    }
+    line += ' ';
+    line += std::to_string(dur);
+    line += '\n';
+    return line;
+  }
+};
 
 /********************************************************************************
  main
@@ -275,9 +690,30 @@ void recursiveSearch(vWord &, Solution &, vSol &, const mChar &, ussWord &);
  argv (unused)
  returns: int
  objective:
- method:
+ method: --read as the first argument runs the results reader (readResults)
+         and --square runs the word square search (runSquares) instead of
+         the letter-disjoint search. --index anywhere adds the per-word index
+         to the results file; it is removed before the positional arguments
+         are read.
  ********************************************************************************/
 int main(int argc, char *argv[]) {
+  if (argc >= 2 && std::string(argv[1]) == "--read") {
+    return readResults(argc, argv);
+  }
+  if (argc >= 2 && std::string(argv[1]) == "--square") {
+    return runSquares(argc, argv);
+  }
+
+  bool writeIndex(false);
+  std::vector<char *> args;
+  for (int i = 0; i < argc; i++) {
+    if (i > 0 && std::string(argv[i]) == "--index") {
+      writeIndex = true;
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
   int rc(0);
   auto startTime = steady_clock::now();
   std::string ts("");
@@ -294,14 +730,14 @@ int main(int argc, char *argv[]) {
   words.clear();
   solutionSets.clear();
 
-  initialization(argc, argv, words, freqMap);
+  initialization(args.size(), args.data(), words, freqMap);
 
   Solution currentSolution; // temporary woekspace
   currentSolution.reset();
 
   if (words.size() > 0) {
     recursiveSearch(words, currentSolution, solutions, freqMap, solutionSets);
-    termination(startTime, solutions);
+    termination(startTime, solutions, words, writeIndex);
   } else {
     rc = 42;
   }
@@ -453,6 +889,7 @@ void prependFNwithTS(std::string &ts, std::string &fp) {
  readWordsFromStorage
  gets:  string address
  sWord address
+ bool (reject words with repeated letters, default true)
  returns: nothing
  objective: get the word list from storage
  fill the vector with new Word objects
@@ -468,7 +905,7 @@ void prependFNwithTS(std::string &ts, std::string &fp) {
  ********************************************************************************/
 
 void readWordsFromStorage(const std::string &inFilePath, vWord &words,
-                          mChar &freqMap) {
+                          mChar &freqMap, bool uniqueLetters) {
   const std::string alphabet("abcdefghijklmnopqrstuvwxyz");
   std::string element;
   for (char c : alphabet) {
@@ -493,7 +930,7 @@ void readWordsFromStorage(const std::string &inFilePath, vWord &words,
 
     for (auto &l : lines) {
       try {
-        Word tmp(l);
+        Word tmp(l, uniqueLetters);
         tmp.setScore(freqMap);
         words.emplace_back(tmp);
       } catch (const DataValidationException &e) {
@@ -510,8 +947,9 @@ void readWordsFromStorage(const std::string &inFilePath, vWord &words,
     formatTime(ts);
     std::cout << ts << " \tLines read: " << linesRead
               << " \tValidation errors: " << rejects
-              << " \tsolutionSize unique letter words kept: " << words.size()
-              << '\n';
+              << (uniqueLetters ? " \tsolutionSize unique letter words kept: "
+                                : " \tsolutionSize letter words kept: ")
+              << words.size() << '\n';
   } else {
     formatTime(ts);
     std::cerr << ts << " \t" << inFilePath << " did not open.\n";
@@ -551,28 +989,570 @@ void writeWordsWithoutDupeLetters(const std::string &fp, vWord &words) {
 /*******************************************************************************
  writeResultsToStorage
  gets: vSol address
+       vWord address (the dictionary the solutions came from)
+       bool (append the per-word index)
  returns: nothing
  objective: put solutions out to storage
  method:  builds file name
- opens outfile
- for  each solution:
-      calculate solution score
-      write a record
+ encodes all solutions into one buffer (see encodeResults)
+ writes the buffer in a single call
  close file
  ********************************************************************************/
 
-void writeResultsToStorage(const vSol &solutions) {
+void writeResultsToStorage(const vSol &solutions, const vWord &words,
+                           bool writeIndex) {
   std::string ts;
   formatTime(ts);
-  ts += "results.txt";
+  ts += "results.wsb";
+  std::string buf;
+  encodeResults(solutions, words, writeIndex, buf);
+  std::ofstream ofx(ts, std::ios::binary);
+  if (ofx.is_open()) {
+    ofx.write(buf.data(), buf.size());
+    ofx.close();
+  } else {
+    std::cerr << ts << " did not open.\n";
+  }
+}
+
+/*******************************************************************************
+ encodeResults
+ gets:  vSol address
+        vWord address
+        bool (append the per-word index)
+        string address (output buffer)
+ returns: nothing (fills in buf)
+ objective: compact binary image of the solutions, layout described at the
+            ResultsFile class.
+ method: the word table holds only words used by some solution, sorted, with
+         their scores. Each record stores its word indices sorted and gap
+         coded, the score as a residual against the table scores (normally
+         zero) and the duration as a delta from the previous record, all as
+         varints. Checkpoints and the per-word index follow when writeIndex
+         is set, located by a fixed size trailer.
+ ********************************************************************************/
+
+void encodeResults(const vSol &solutions, const vWord &words,
+                   bool writeIndex, std::string &buf) {
+  std::unordered_map<std::string, int> dictScores;
+  for (auto &aWord : words) {
+    dictScores[aWord.getWord()] = aWord.getScore();
+  }
+
+  std::set<std::string> used;
+  for (auto &solution : solutions) {
+    for (auto &aWord : solution.getWordCollection()) {
+      used.insert(aWord.getWord());
+    }
+  }
+  std::vector<std::string> table(used.begin(), used.end());
+  std::unordered_map<std::string, ul> tableIndex;
+  for (ul i = 0; i < table.size(); i++) {
+    tableIndex[table[i]] = i;
+  }
+
+  buf.clear();
+  buf += RESULTS_MAGIC;
+  buf.push_back(RESULTS_VERSION);
+  buf.push_back(writeIndex ? FLAG_WORD_INDEX : 0);
+  putFixed64(buf, hashDictionary(words));
+  putVarint(buf, words.size());
+  putVarint(buf, table.size());
+  for (auto &w : table) {
+    buf += w;
+    putVarint(buf, dictScores[w]);
+  }
+  putVarint(buf, solutions.size());
+
+  size_t recordsStart(buf.size());
+  std::vector<std::pair<size_t, ul>> checkpoints;
+  std::vector<std::vector<ul>> wordIndex(table.size());
+  std::array<ul, SOLUTION_SIZE> indices;
+  ul prevDur(0);
+  for (ul k = 0; k < solutions.size(); k++) {
+    if (k % CHECKPOINT_INTERVAL == 0) {
+      checkpoints.emplace_back(buf.size() - recordsStart, prevDur);
+    }
+    const Solution &solution(solutions[k]);
+    int i(0);
+    int64_t sum(0);
+    for (auto &aWord : solution.getWordCollection()) {
+      indices[i++] = tableIndex[aWord.getWord()];
+      sum += dictScores[aWord.getWord()];
+    }
+    std::sort(indices.begin(), indices.end());
+    for (i = 0; i < SOLUTION_SIZE; i++) {
+      putVarint(buf, indices[i] - (i > 0 ? indices[i - 1] : 0));
+      wordIndex[indices[i]].push_back(k);
+    }
+    putSigned(buf, solution.getScore() - sum);
+    putSigned(buf, static_cast<int64_t>(solution.getDur()) -
+                       static_cast<int64_t>(prevDur));
+    prevDur = solution.getDur();
+  }
+
+  if (writeIndex) {
+    uint64_t indexStart(buf.size());
+    putVarint(buf, CHECKPOINT_INTERVAL);
+    putVarint(buf, checkpoints.size());
+    size_t prevOffset(0);
+    for (auto &cp : checkpoints) {
+      putVarint(buf, cp.first - prevOffset);
+      putVarint(buf, cp.second);
+      prevOffset = cp.first;
+    }
+    for (auto &ordinals : wordIndex) {
+      putVarint(buf, ordinals.size());
+      ul prev(0);
+      for (auto ordinal : ordinals) {
+        putVarint(buf, ordinal - prev);
+        prev = ordinal;
+      }
+    }
+    putFixed64(buf, indexStart);
+    buf += INDEX_MAGIC;
+  }
+}
+
+/*******************************************************************************
+ readResults
+ gets: argc, argv
+       --read <results.wsb> [--text <out.txt>] [--word <w>]...
+       [--min-score <n>] [--max-score <n>] [--limit <n>] [--dict <words.txt>]
+ returns: int (0 ok, 1 bad arguments, 2 unreadable file)
+ objective: turn a binary results file back into the text layout, keeping only
+            solutions that contain every --word and fall in the score range.
+ method: with --word and a word index, visit only the intersection of the
+         words' record lists, seeking from the nearest checkpoint. Otherwise
+         decode every record in order. --dict reloads a word list and warns
+         when its hash differs from the one in the header.
+ ********************************************************************************/
+
+int readResults(const int &argc, char *argv[]) {
+  std::string ts("");
+  std::string iFilePath;
+  std::string textPath;
+  std::string dictPath;
+  std::vector<std::string> wanted;
+  long minScore(std::numeric_limits<long>::min());
+  long maxScore(std::numeric_limits<long>::max());
+  ul limit(std::numeric_limits<ul>::max());
+
+  try {
+    for (int i = 2; i < argc; i++) {
+      std::string arg(argv[i]);
+      bool hasValue(i + 1 < argc);
+      if (arg == "--text" && hasValue) {
+        textPath = argv[++i];
+      } else if (arg == "--dict" && hasValue) {
+        dictPath = argv[++i];
+      } else if (arg == "--word" && hasValue) {
+        wanted.emplace_back(argv[++i]);
+        makeLowercase(wanted.back());
+      } else if (arg == "--min-score" && hasValue) {
+        minScore = parseOption(arg, argv[++i]);
+      } else if (arg == "--max-score" && hasValue) {
+        maxScore = parseOption(arg, argv[++i]);
+      } else if (arg == "--limit" && hasValue) {
+        limit = parseOption(arg, argv[++i], 1);
+      } else if (iFilePath.empty() && arg.compare(0, 2, "--") != 0) {
+        iFilePath = arg;
+      } else {
+        throw std::invalid_argument(arg);
+      }
+    }
+  } catch (const std::logic_error &e) {
+    std::cerr << "Bad argument: \t" << e.what() << '\n';
+    return 1;
+  }
+  if (iFilePath.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " --read <results.wsb> [--text <out.txt>] [--word <w>]..."
+                 " [--min-score <n>] [--max-score <n>] [--limit <n>]"
+                 " [--dict <words.txt>]\n";
+    return 1;
+  }
+
+  ResultsFile results;
+  try {
+    if (!results.load(iFilePath)) {
+      formatTime(ts);
+      std::cerr << ts << " \t" << iFilePath << " did not open.\n";
+      return 2;
+    }
+  } catch (const DataValidationException &e) {
+    std::cerr << iFilePath << " \t" << e.what() << '\n';
+    return 2;
+  }
+
+  if (!dictPath.empty()) {
+    vWord dictWords;
+    mChar freqMap;
+    readWordsFromStorage(dictPath, dictWords, freqMap);
+    if (hashDictionary(dictWords) != results.getDictHash()) {
+      std::cerr << dictPath << " does not match the dictionary used for "
+                << iFilePath << ".\n";
+    }
+  }
+
+  std::ofstream ofx;
+  if (!textPath.empty()) {
+    ofx.open(textPath);
+    if (!ofx.is_open()) {
+      std::cerr << textPath << " did not open.\n";
+      return 2;
+    }
+  }
+  std::ostream &out(textPath.empty() ? std::cout : ofx);
+
+  std::vector<long> wordIds;
+  bool possible(true);
+  for (auto &w : wanted) {
+    wordIds.push_back(results.findWord(w));
+    possible = possible && wordIds.back() >= 0;
+  }
+  std::sort(wordIds.begin(), wordIds.end());
+  wordIds.erase(std::unique(wordIds.begin(), wordIds.end()), wordIds.end());
+
+  ul written(0);
+  std::array<ul, SOLUTION_SIZE> indices;
+  int score;
+  size_t pos;
+  ul dur;
+  auto emit = [&]() {
+    if (score >= minScore && score <= maxScore) {
+      out << results.formatRecord(indices, score, dur);
+      written++;
+    }
+  };
+
+  try {
+    if (!possible) {
+      // a wanted word appears in no solution
+    } else if (!wordIds.empty() && results.hasWordIndex()) {
+      // hits are sorted: decode forward within a checkpoint block and only
+      // seek when the next hit lies in a later block
+      ul interval(std::max<ul>(1, results.getCheckpointInterval()));
+      ul next(0); // ordinal of the record at pos
+      bool positioned(false);
+      for (auto ordinal : results.solutionsWithWords(wordIds)) {
+        if (written >= limit) {
+          break;
+        }
+        if (!positioned || ordinal / interval > next / interval) {
+          results.seekRecord(ordinal, pos, dur);
+        } else {
+          results.skipRecords(ordinal - next, pos, dur);
+        }
+        results.decodeRecord(pos, dur, indices, score);
+        next = ordinal + 1;
+        positioned = true;
+        emit();
+      }
+    } else {
+      results.seekRecord(0, pos, dur);
+      for (ul k = 0; k < results.getSolutionCount() && written < limit; k++) {
+        results.decodeRecord(pos, dur, indices, score);
+        bool all(true);
+        for (auto id : wordIds) {
+          all = all && std::binary_search(indices.begin(), indices.end(),
+                                          static_cast<ul>(id));
+        }
+        if (all) {
+          emit();
+        }
+      }
+    }
+  } catch (const DataValidationException &e) {
+    std::cerr << iFilePath << " \t" << e.what() << '\n';
+    return 2;
+  }
+
+  if (!textPath.empty()) {
+    ofx.close();
+    formatTime(ts);
+    std::cout << ts << " \t" << written << " of "
+              << results.getSolutionCount() << " solutions written to "
+              << textPath << ".\n";
+  }
+  return 0;
+}
+
+/*******************************************************************************
+ runSquares
+ gets: argc, argv
+       --square [<words.txt>] [--double] [--threads <n>]
+ returns: int (0 ok, 1 bad arguments, 42 no words)
+ --threads must be positive and is capped at the number of hardware threads.
+ objective: find 5x5 word squares, every row and column a dictionary word.
+ method: load the word list keeping words with repeated letters, search with
+         squareSearch, write the squares to storage and report the time.
+ ********************************************************************************/
+
+int runSquares(const int &argc, char *argv[]) {
+  std::string iFilePath(
+      "/Users/prh/code/txt/td/words.txt"); // default file path
+  bool doubleSquare(false);
+  const unsigned maxThreads(std::max(1u, std::thread::hardware_concurrency()));
+  unsigned threads(maxThreads);
+
+  try {
+    for (int i = 2; i < argc; i++) {
+      std::string arg(argv[i]);
+      if (arg == "--double") {
+        doubleSquare = true;
+      } else if (arg == "--threads" && i + 1 < argc) {
+        long n(parseOption(arg, argv[++i], 1));
+        threads = std::min(static_cast<unsigned long>(n),
+                           static_cast<unsigned long>(maxThreads));
+      } else if (arg.compare(0, 2, "--") != 0) {
+        iFilePath = arg;
+      } else {
+        throw std::invalid_argument(arg);
+      }
+    }
+  } catch (const std::logic_error &e) {
+    std::cerr << "Bad argument: \t" << e.what() << '\n';
+    return 1;
+  }
+
+  auto startTime = steady_clock::now();
+  std::string ts("");
+  formatTime(ts);
+  std::cout << ts << " \tStarting " << (doubleSquare ? "double " : "")
+            << "word square search on " << threads << " threads.\n";
+
+  mChar freqMap;
+  vWord words;
+  readWordsFromStorage(iFilePath, words, freqMap, false);
+  if (words.empty()) {
+    return 42;
+  }
+
+  std::vector<std::string> squares;
+  squareSearch(words, doubleSquare, threads, squares);
+  writeSquaresToStorage(squares, freqMap);
+
+  std::string durStr("");
+  formatSteadyClockDuration(durStr, startTime, steady_clock::now(), true);
+  formatTime(ts);
+  std::cout << ts << " \t" << durStr << '\n';
+  std::cout << ts << " \tWord square search complete. Squares identified: "
+            << squares.size() << ".\n";
+  return 0;
+}
+
+/*******************************************************************************
+ squareSearch
+ gets:  vWord address
+        bool (double squares: all ten words different)
+        unsigned (thread count)
+        vector<string> address (squares, rows concatenated)
+ returns: nothing (fills in squares, sorted)
+ objective: enumerate word squares in parallel
+ method: build a PrefixTrie from the lowercase words. Each thread owns a
+         Square workspace and takes first rows from a shared counter until
+         they run out, so uneven first rows balance across threads.
+ ********************************************************************************/
+
+void squareSearch(const vWord &words, bool doubleSquare, unsigned threads,
+                  std::vector<std::string> &squares) {
+  std::vector<std::string> list;
+  for (auto &aWord : words) {
+    const std::string &w(aWord.getWord());
+    if (std::all_of(w.begin(), w.end(),
+                    [](char c) { return c >= 'a' && c <= 'z'; })) {
+      list.push_back(w);
+    }
+  }
+  std::sort(list.begin(), list.end());
+  list.erase(std::unique(list.begin(), list.end()), list.end());
+
+  PrefixTrie trie;
+  trie.build(list);
+
+  std::atomic<size_t> next(0);
+  std::vector<std::vector<std::string>> perThread(threads);
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++) {
+    pool.emplace_back([&, t]() {
+      Square square(trie, doubleSquare);
+      for (size_t i = next++; i < list.size(); i = next++) {
+        square.searchFirstRow(list[i]);
+      }
+      perThread[t] = square.getFound();
+    });
+  }
+  for (auto &th : pool) {
+    th.join();
+  }
+
+  squares.clear();
+  for (auto &found : perThread) {
+    squares.insert(squares.end(), found.begin(), found.end());
+  }
+  std::sort(squares.begin(), squares.end());
+}
+
+/*******************************************************************************
+ writeSquaresToStorage
+ gets:  vector<string> address (squares, rows concatenated)
+        mChar address
+ returns: nothing
+ objective: put word squares out to storage
+ method: one record per square: score (sum of the row scores) and the five
+         rows.
+ ********************************************************************************/
+
+void writeSquaresToStorage(const std::vector<std::string> &squares,
+                           mChar &freqMap) {
+  std::string ts;
+  formatTime(ts);
+  ts += "squares.txt";
   std::ofstream ofx(ts);
-  for (auto solution : solutions) {
-    ofx << solution.formatSolution();
+  if (!ofx.is_open()) {
+    std::cerr << ts << " did not open.\n";
+    return;
+  }
+  for (auto &square : squares) {
+    ul score(0);
+    std::string rows;
+    for (int r = 0; r < SOLUTION_SIZE; r++) {
+      std::string row(square.substr(r * SOLUTION_SIZE, SOLUTION_SIZE));
+      score += scoreString(freqMap, row);
+      rows += ' ' + row;
+    }
+    ofx << score << rows << '\n';
   }
-  ofx << std::endl;
   ofx.close();
 }
 
+/*******************************************************************************
+ scoreString
+ gets:  mChar address
+        string address
+ returns: sum of the letter frequencies in the string
+ ********************************************************************************/
+
+ul scoreString(mChar &freqMap, const std::string &aString) {
+  ul sum(0);
+  for (auto c : aString) {
+    sum += freqMap[c];
+  }
+  return sum;
+}
+
+/*******************************************************************************
+ parseOption
+ gets:  string address (option name, for the error message)
+        string address (option value)
+        long (smallest value accepted)
+ returns: the value as a long
+ objective: strict parsing of numeric command line options
+ method: the whole value must be a number that fits in a long and is at least
+         minValue; otherwise std::invalid_argument("<option> <value>") is
+         thrown for the caller's bad argument handler.
+ ********************************************************************************/
+
+long parseOption(const std::string &arg, const std::string &value,
+                 long minValue) {
+  size_t used(0);
+  long n(0);
+  try {
+    n = std::stol(value, &used);
+  } catch (const std::logic_error &) {
+    used = 0;
+  }
+  if (used == 0 || used != value.size() || n < minValue) {
+    throw std::invalid_argument(arg + " " + value);
+  }
+  return n;
+}
+
+/*******************************************************************************
+ hashDictionary
+ gets: vWord address
+ returns: 64 bit FNV-1a hash
+ objective: identify the word list a results file was built from
+ method: hash the words in sorted order so load order does not matter
+ ********************************************************************************/
+
+uint64_t hashDictionary(const vWord &words) {
+  std::vector<std::string> sorted;
+  for (auto &aWord : words) {
+    sorted.emplace_back(aWord.getWord());
+  }
+  std::sort(sorted.begin(), sorted.end());
+  uint64_t h(14695981039346656037ULL);
+  for (auto &w : sorted) {
+    for (unsigned char c : w) {
+      h = (h ^ c) * 1099511628211ULL;
+    }
+    h = (h ^ '\n') * 1099511628211ULL;
+  }
+  return h;
+}
+
+/*******************************************************************************
+ putVarint, putSigned, putFixed64, getVarint, getSigned, getFixed64
+ objective: byte level helpers for the results file. Varints are LEB128,
+            signed values are zigzag mapped first, fixed values little endian.
+            All take 64 bit values so the file layout does not depend on the
+            width of long.
+            The getters throw DataValidationException past the end of buf.
+ ********************************************************************************/
+
+void putVarint(std::string &buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  buf.push_back(static_cast<char>(v));
+}
+
+void putSigned(std::string &buf, int64_t v) {
+  putVarint(buf, (static_cast<uint64_t>(v) << 1) ^
+                     static_cast<uint64_t>(v >> 63));
+}
+
+void putFixed64(std::string &buf, uint64_t v) {
+  for (size_t i = 0; i < sizeof(v); i++) {
+    buf.push_back(static_cast<char>(v >> (8 * i)));
+  }
+}
+
+uint64_t getVarint(const std::string &buf, size_t &pos) {
+  uint64_t v(0);
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (pos >= buf.size()) {
+      throw DataValidationException("Truncated results file.");
+    }
+    unsigned char b(buf[pos++]);
+    v |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return v;
+    }
+  }
+  throw DataValidationException("Malformed varint in results file.");
+}
+
+int64_t getSigned(const std::string &buf, size_t &pos) {
+  uint64_t v(getVarint(buf, pos));
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+uint64_t getFixed64(const std::string &buf, size_t pos) {
+  if (pos + sizeof(uint64_t) > buf.size()) {
+    throw DataValidationException("Truncated results file.");
+  }
+  uint64_t v(0);
+  for (size_t i = 0; i < sizeof(v); i++) {
+    v |= static_cast<uint64_t>(static_cast<unsigned char>(buf[pos + i]))
+         << (8 * i);
+  }
+  return v;
+}
+
 /*******************************************************************************
  formatSteadyClockDuration
  gets:  string
@@ -625,14 +1605,17 @@ void formatSteadyClockDuration(std::string &durStr,
  termination
  gets:  string (scratch)
  vSol (solutionsg)
+ vWord (dictionary, for the results file header)
+ bool (append the per-word index)
  returns: nothing
  objective: do whatever needs to be done to wrap things up.
  method: results get written to storage
  alerts operator that this job ended normally.
  ********************************************************************************/
 
-void termination(const steady_clock::time_point &startTime, vSol &solutions) {
-  writeResultsToStorage(solutions);
+void termination(const steady_clock::time_point &startTime, vSol &solutions,
+                 const vWord &words, bool writeIndex) {
+  writeResultsToStorage(solutions, words, writeIndex);
   auto stopTime = steady_clock::now();
   std::string durStr("");
   formatSteadyClockDuration(durStr, startTime, stopTime, true);